@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "logger.h"
+
+static const char *levels[3] = {"ERROR", "WARN", "INFO"};
+static const char *events[] = {"", "SERVER_START", "SERVER_STOP", "TASK_ADD", "TASK_CANCEL", "TASK_DISPLAY",
+                               "TASK_STOP", "TASK_FIRE", "TASK_EXIT", "TASK_REJECT"};
+static const int events_count = sizeof(events) / sizeof(events[0]);
+
+struct filter_t {
+    int event_id;
+    int level;
+    long task_id;
+};
+
+int find_event_id(const char* name);
+int matches(const struct filter_t *filter, const struct log_event_t *event);
+void print_event(const struct log_event_t *event);
+void print_usage(const char* program);
+
+int main(int argc, char **argv) {
+    struct filter_t filter = {0, 3, 0};
+
+    int opt;
+    while((opt = getopt(argc, argv, "e:l:t:")) != -1) {
+        switch(opt) {
+            case 'e':
+                if((filter.event_id = find_event_id(optarg)) == 0) {
+                    fprintf(stderr, "Unknown event: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'l':
+                filter.level = (int) strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                filter.task_id = strtol(optarg, NULL, 10);
+                break;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(optind >= argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen(argv[optind], "rb");
+    if(file == NULL) {
+        perror(argv[optind]);
+        return 2;
+    }
+
+    struct log_event_header_t header;
+    if(fread(&header, sizeof(struct log_event_header_t), 1, file) != 1
+            || memcmp(header.magic, LOG_EVENT_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s is not an event log.\n", argv[optind]);
+        fclose(file);
+        return 3;
+    }
+    if(header.version != LOG_EVENT_VERSION) {
+        fprintf(stderr, "Unsupported event log version: %u.\n", header.version);
+        fclose(file);
+        return 4;
+    }
+
+    struct log_event_t event;
+    while(fread(&event, sizeof(struct log_event_t), 1, file) == 1) {
+        if(matches(&filter, &event))
+            print_event(&event);
+    }
+
+    fclose(file);
+    return 0;
+}
+
+int find_event_id(const char* name) {
+    for(int i = 1; i < events_count; i++) {
+        if(strcmp(events[i], name) == 0)
+            return i;
+    }
+    return 0;
+}
+
+int matches(const struct filter_t *filter, const struct log_event_t *event) {
+    if(filter->event_id && filter->event_id != event->event_id)
+        return 0;
+    if(filter->level < (int) event->level)
+        return 0;
+    if(filter->task_id && filter->task_id != event->task_id)
+        return 0;
+    return 1;
+}
+
+void print_event(const struct log_event_t *event) {
+    char log_time[26];
+    time_t t = (time_t) (event->timestamp / 1000000000);
+    struct tm* tm = localtime(&t);
+    strftime(log_time, 26, "%Y-%m-%d %H:%M:%S", tm);
+
+    const char* level = event->level >= 1 && event->level <= 3 ? levels[event->level - 1] : "?";
+    const char* name = event->event_id > 0 && event->event_id < events_count ? events[event->event_id] : "UNKNOWN";
+
+    printf("(%s) (%s.%09ld) %s", level, log_time, (long) (event->timestamp % 1000000000), name);
+    switch(event->event_id) {
+        case EV_SERVER_START:
+        case EV_SERVER_STOP:
+            printf(" pid=%d", event->pid);
+            break;
+        case EV_TASK_ADD:
+        case EV_TASK_CANCEL:
+            printf(" task=%ld", (long) event->task_id);
+            break;
+        case EV_TASK_FIRE:
+            printf(" task=%ld pid=%d lateness=%.6fs", (long) event->task_id, event->pid, event->lateness / 1e9);
+            if(event->exit_code)
+                printf(" error=%s", strerror(event->exit_code));
+            break;
+        case EV_TASK_EXIT:
+            printf(" task=%ld pid=%d exit_code=%d", (long) event->task_id, event->pid, event->exit_code);
+            break;
+        case EV_TASK_REJECT:
+            printf(" client=%d status=%d", event->pid, event->exit_code);
+            break;
+    }
+    printf("\n");
+}
+
+void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [-e event] [-l level] [-t task_id] file\n", program);
+}
@@ -7,11 +7,14 @@
 #include <semaphore.h>
 #include <stdarg.h>
 #include <time.h>
+#include <fcntl.h>
+#include <sys/wait.h>
 #include "logger.h"
 
 static volatile sig_atomic_t current_level = 3;
 static atomic_int initialized = 0;
 static FILE* file;
+static int event_fd = -1;
 static sem_t sem;
 static pthread_mutex_t mutex;
 static pthread_t dump_thread;
@@ -20,10 +23,13 @@ static int dump_sig_num;
 static int log_sig_num;
 static const char *logs[3] = {"ERROR", "WARN", "INFO"};
 struct dump_t {
-    void* (*get_dump_data)();
-    size_t size;
+    void (*lock_dump_data)();
+    void (*unlock_dump_data)();
+    int (*write_dump_data)(int);
 };
 static struct dump_t* dump_data;
+static unsigned long dump_sequence = 0;
+static pid_t dump_pid = 0;
 
 void log_sig_handler(int signo, siginfo_t* info, void* other);
 void dump_sig_handler();
@@ -31,7 +37,8 @@ void* signal_receiver(void* arg);
 void* dump(void* arg);
 
 
-int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*get_dump_data_fun)(), size_t dump_size) {
+int logger_init(int log_sig_no, char* log_filename, char* event_filename, int dump_sig_no, void (*lock_dump_data_fun)(),
+                void (*unlock_dump_data_fun)(), int (*write_dump_data_fun)(int)) {
     if(initialized)
         return 1;
 
@@ -39,15 +46,29 @@ int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*ge
         return 2;
     setbuf(file, NULL);
 
+    if((event_fd = open(event_filename, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644)) == -1) {
+        fclose(file);
+        return 12;
+    }
+
+    struct log_event_header_t header = {LOG_EVENT_MAGIC, LOG_EVENT_VERSION};
+    if(write(event_fd, &header, sizeof(struct log_event_header_t)) != sizeof(struct log_event_header_t)) {
+        fclose(file);
+        close(event_fd);
+        return 13;
+    }
+
     dump_sig_num = dump_sig_no;
     log_sig_num = log_sig_no;
     dump_data = malloc(sizeof(struct dump_t));
     if(dump_data == NULL) {
         fclose(file);
+        close(event_fd);
         return 3;
     }
-    dump_data->get_dump_data = get_dump_data_fun;
-    dump_data->size = dump_size;
+    dump_data->lock_dump_data = lock_dump_data_fun;
+    dump_data->unlock_dump_data = unlock_dump_data_fun;
+    dump_data->write_dump_data = write_dump_data_fun;
 
     sigset_t block_set;
     sigemptyset(&block_set);
@@ -57,12 +78,14 @@ int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*ge
 
     if(sem_init(&sem, 0, 0)) {
         fclose(file);
+        close(event_fd);
         free(dump_data);
         return 4;
     }
 
     if(pthread_mutex_init(&mutex, NULL)) {
         fclose(file);
+        close(event_fd);
         free(dump_data);
         sem_destroy(&sem);
         return 5;
@@ -77,6 +100,7 @@ int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*ge
     action.sa_flags = SA_SIGINFO;
     if(sigaction(log_sig_no, &action, NULL) != 0) {
         fclose(file);
+        close(event_fd);
         sem_destroy(&sem);
         pthread_mutex_destroy(&mutex);
         free(dump_data);
@@ -89,6 +113,7 @@ int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*ge
     if(sigaction(dump_sig_no, &action, NULL)) {
         signal(log_sig_num, SIG_DFL);
         fclose(file);
+        close(event_fd);
         sem_destroy(&sem);
         pthread_mutex_destroy(&mutex);
         free(dump_data);
@@ -99,6 +124,7 @@ int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*ge
         signal(dump_sig_num, SIG_DFL);
         signal(log_sig_num, SIG_DFL);
         fclose(file);
+        close(event_fd);
         free(dump_data);
         sem_destroy(&sem);
         pthread_mutex_destroy(&mutex);
@@ -110,6 +136,7 @@ int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*ge
         signal(dump_sig_num, SIG_DFL);
         signal(log_sig_num, SIG_DFL);
         fclose(file);
+        close(event_fd);
         free(dump_data);
         sem_destroy(&sem);
         pthread_mutex_destroy(&mutex);
@@ -121,6 +148,7 @@ int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*ge
         signal(dump_sig_num, SIG_DFL);
         signal(log_sig_num, SIG_DFL);
         fclose(file);
+        close(event_fd);
         free(dump_data);
         sem_destroy(&sem);
         pthread_mutex_destroy(&mutex);
@@ -133,6 +161,7 @@ int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*ge
         signal(dump_sig_num, SIG_DFL);
         signal(log_sig_num, SIG_DFL);
         fclose(file);
+        close(event_fd);
         free(dump_data);
         sem_destroy(&sem);
         pthread_mutex_destroy(&mutex);
@@ -168,23 +197,43 @@ void* dump(void* arg) {
     sigfillset(&set);
     pthread_sigmask(SIG_SETMASK, &set, NULL);
 
+    pid_t parent_pid = getpid();
     while(1) {
         sem_wait(&sem);
+        dump_sequence++;
         char filename[50];
-        char dump_time[30];
-        time_t t = time(NULL);
-        struct tm* tm = localtime(&t);
-        strftime(dump_time, 30, "%Y-%m-%d %H-%M-%S", tm);
-        sprintf(filename, "dump %s.txt", dump_time);
-        FILE* dump_file = fopen(filename, "w");
-        if(dump_file == NULL) {
-            return NULL;
+        sprintf(filename, "dump_%d_%06lu.bin", parent_pid, dump_sequence);
+
+        dump_data->lock_dump_data();
+        pid_t child_pid = fork();
+        if(child_pid > 0)
+            dump_pid = child_pid;
+        dump_data->unlock_dump_data();
+
+        if(child_pid == -1)
+            continue;
+
+        if(child_pid == 0) {
+            int fd = open(filename, O_WRONLY | O_CREAT | O_EXCL, 0644);
+            if(fd == -1)
+                _exit(1);
+            int result = dump_data->write_dump_data(fd);
+            if(close(fd) || result)
+                _exit(2);
+            _exit(0);
         }
-        fwrite(dump_data->get_dump_data(), dump_data->size, sizeof(char), dump_file);
-        fclose(dump_file);
+
+        waitpid(child_pid, NULL, 0);
+        dump_data->lock_dump_data();
+        dump_pid = 0;
+        dump_data->unlock_dump_data();
     }
 }
 
+pid_t logger_dump_pid() {
+    return dump_pid;
+}
+
 int logger_log(int level, const char* format, ...) {
     if(!initialized)
         return -1;
@@ -215,11 +264,40 @@ int logger_log(int level, const char* format, ...) {
     return result;
 }
 
+int logger_event(int level, int event_id, long task_id, pid_t pid, long lateness, int exit_code) {
+    if(!initialized)
+        return -1;
+
+    if(level < 0 || level > 3)
+        return 2;
+
+    if(current_level < level)
+        return -3;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    struct log_event_t event;
+    event.event_id = event_id;
+    event.level = level;
+    event.timestamp = (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+    event.task_id = task_id;
+    event.lateness = lateness;
+    event.pid = pid;
+    event.exit_code = exit_code;
+
+    if(write(event_fd, &event, sizeof(struct log_event_t)) != sizeof(struct log_event_t))
+        return 1;
+
+    return 0;
+}
+
 void logger_destroy() {
     if(!initialized)
         return;
 
     fclose(file);
+    close(event_fd);
     pthread_cancel(signal_thread);
     pthread_cancel(dump_thread);
     free(dump_data);
@@ -1,8 +1,35 @@
 #ifndef CHRONO_LOGGER_H
 #define CHRONO_LOGGER_H
 
-int logger_init(int log_sig_no, char* log_filename, int dump_sig_no,  void* (*get_dump_data)(), size_t dump_size);
+#include <stdint.h>
+#include <sys/types.h>
+
+#define LOG_EVENT_MAGIC "CHEV"
+#define LOG_EVENT_VERSION 1
+
+enum log_event_id_t {EV_SERVER_START = 1, EV_SERVER_STOP, EV_TASK_ADD, EV_TASK_CANCEL, EV_TASK_DISPLAY, EV_TASK_STOP,
+        EV_TASK_FIRE, EV_TASK_EXIT, EV_TASK_REJECT};
+
+struct log_event_header_t {
+    char magic[4];
+    uint32_t version;
+};
+
+struct log_event_t {
+    uint32_t event_id;
+    uint32_t level;
+    int64_t timestamp;
+    int64_t task_id;
+    int64_t lateness;
+    int32_t pid;
+    int32_t exit_code;
+};
+
+int logger_init(int log_sig_no, char* log_filename, char* event_filename, int dump_sig_no, void (*lock_dump_data)(),
+                void (*unlock_dump_data)(), int (*write_dump_data)(int));
 void logger_destroy();
 int logger_log(int level, const char* format, ...);
+int logger_event(int level, int event_id, long task_id, pid_t pid, long lateness, int exit_code);
+pid_t logger_dump_pid();
 
 #endif
@@ -9,34 +9,87 @@
 #include <time.h>
 #include <signal.h>
 #include <pthread.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/wait.h>
 #include "logger.h"
 
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
-static char *data;
-void* get_dump_data();
+#define DEFAULT_QUEUE_DEPTH 10
+#define DEFAULT_MAX_TASKS 1024
+#define DEFAULT_MAX_MEMORY (1024 * 1024)
+#define CLIENT_TIMEOUT 2
+#define SERVER_TIMEOUT 1
+#define DUMP_MAGIC "CHRD"
+#define DUMP_VERSION 1
+#define TIME_SPEC_SIZE 256
+#define QUERY_DATA_SIZE 1024
+#define MAX_SCHEDULE_SECONDS (LONG_MAX / 1000000000)
 
 enum command_t {ADD, CANCEL, DISPLAY, STOP};
 const char *commands[] = {"add", "cancel", "display", "stop"};
+const unsigned int command_priorities[] = {0, 2, 1, 3};
 static pthread_mutex_t mutex;
 
+enum status_t {OK, OVER_TASK_LIMIT, OVER_MEMORY_LIMIT, INVALID_QUERY, TIMER_ERROR};
+const char *statuses[] = {"ok", "task limit reached", "memory limit reached", "invalid query", "cannot schedule task"};
+
+struct config_t {
+    long queue_depth;
+    long max_tasks;
+    size_t max_memory;
+};
+
+struct stats_t {
+    long added;
+    long rejected;
+    long cancelled;
+    long fired;
+};
+
+struct child_t {
+    pid_t pid;
+    long task_id;
+    struct child_t *next;
+};
+
+static long task_count;
+static size_t task_memory;
+static struct stats_t stats;
+static struct child_t *children;
+static pthread_cond_t children_cond;
+static pthread_t reaper_thread;
+
 struct query_t {
     enum command_t command;
-    char timer_spec[256];
-    char task[256];
+    pid_t client_pid;
+    long task_id;
+    long execution_time;
+    long interval_time;
+    int is_absolute;
+    int argc;
+    size_t data_length;
+    char data[QUERY_DATA_SIZE];
 };
 
 struct response_t {
+    enum status_t status;
     long task_id;
-    char time_spec[256];
+    char time_spec[TIME_SPEC_SIZE];
     char task[256];
 };
 
 struct task_t {
     long task_id;
     timer_t timer_id;
-    char time_spec[256];
+    char *time_spec;
     char **argv;
+    struct query_t *query;
+    size_t memory;
+    long next_execution;
+    long interval_time;
     int is_cyclic;
     int is_done;
 };
@@ -51,72 +104,172 @@ struct linked_list_t {
     struct node_t *tail;
 };
 
+struct dump_header_t {
+    char magic[4];
+    uint32_t version;
+    int64_t timestamp;
+    int64_t task_count;
+    int64_t tasks_added;
+    int64_t tasks_rejected;
+    int64_t tasks_cancelled;
+    int64_t tasks_fired;
+};
+
+struct dump_task_t {
+    int64_t task_id;
+    int64_t next_execution;
+    int64_t interval_time;
+    int32_t is_cyclic;
+    int32_t is_done;
+    uint32_t time_spec_length;
+    uint32_t argv_length;
+};
+
+_Static_assert(sizeof(struct dump_header_t) == 56, "dump header layout changed");
+_Static_assert(sizeof(struct dump_task_t) == 40, "dump task layout changed");
+
+static struct linked_list_t *dump_list;
+
 struct linked_list_t* ll_create();
 int ll_push_back(struct linked_list_t* ll, struct task_t **new_task);
 int ll_size(const struct linked_list_t* ll);
-void ll_remove(struct linked_list_t* ll, long index);
+void ll_remove(struct linked_list_t* ll, long index, int is_rollback);
 void ll_clear(struct linked_list_t* ll);
+void ll_remove_done(struct linked_list_t* ll);
+
+void lock_dump_data();
+void unlock_dump_data();
+int write_dump_data(int fd);
+int write_dump_bytes(int fd, const void *buffer, size_t size);
 
 void timer_notification_thread(union sigval arg);
-void send_task_list(const struct linked_list_t *ll);
-void get_argv_for_task(struct task_t *timer_task, struct query_t query);
-int get_task_time(struct query_t *query, long *task_execution_time, long *interval_time);
+void* reap_children(void* arg);
+void unlock_mutex(void* arg);
+void clear_children();
+void send_task_list(const struct linked_list_t *ll, pid_t client_pid);
+void send_add_response(pid_t client_pid, enum status_t status, long task_id);
+mqd_t open_response_queue(pid_t client_pid, int flags);
+void close_response_queue(mqd_t mq_response_queue, pid_t client_pid);
+void get_timeout(struct timespec *timeout, int seconds);
+void get_config(struct config_t *config);
+long get_config_value(const char *name, long default_value);
+long get_queue_depth_limit();
+struct task_t* create_task(struct query_t *query);
+void reject_task(pid_t client_pid, enum status_t status);
+int read_query_string(struct query_t *query, size_t *offset, char **string);
+void free_task(struct task_t *timer_task);
 
 void run_client(const mqd_t *mq_queries_to_server, int argc, char **argv);
-void fill_add_query(int argc, char** argv, struct query_t *query);
-void display_task_list();
+int send_query(const mqd_t *mq_queries_to_server, struct query_t *query);
+int fill_add_query(int argc, char** argv, struct query_t *query);
+int write_query_string(struct query_t *query, const char *string);
+int get_task_time(char *timer_spec, long *task_execution_time, long *interval_time);
+int get_duration(long *duration);
+int get_time_field(const char *delimiters, long min, long max, long *value);
+
+void receive_add_response(mqd_t mq_response_from_server);
+void display_task_list(mqd_t mq_response_from_server);
 
 int main(int argc, char **argv) {
     mqd_t mq_queries_to_server = mq_open("/mq_queries_queue", O_WRONLY);
 
     if(mq_queries_to_server == -1) {
         if(fork() != 0) {
+            struct config_t config;
+            get_config(&config);
+
             struct mq_attr attr;
-            attr.mq_maxmsg = 10;
+            attr.mq_maxmsg = config.queue_depth;
             attr.mq_msgsize = sizeof(struct query_t);
             attr.mq_flags = 0;
 
             int dump_sig_no = 36;
             int log_sig_no = 37;
             char* log_filename = "logger.log";
-            size_t size = 50;
-            data = calloc(size, sizeof(char));
-            memset(data, '1', sizeof(char) * size);
+            char* event_filename = "events.bin";
 
-            logger_init(log_sig_no, log_filename, dump_sig_no, &get_dump_data, size);
-            logger_log(3, "(%s:%d) %s", __FILENAME__, __LINE__, "Server has started.");
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&children_cond, NULL);
+            logger_init(log_sig_no, log_filename, event_filename, dump_sig_no, &lock_dump_data, &unlock_dump_data,
+                        &write_dump_data);
+            logger_event(3, EV_SERVER_START, 0, getpid(), 0, 0);
+
+            if(pthread_create(&reaper_thread, NULL, reap_children, NULL)) {
+                logger_log(1, "(%s:%d) %s", __FILENAME__, __LINE__, "Cannot start child reaper.");
+                pthread_cond_destroy(&children_cond);
+                pthread_mutex_destroy(&mutex);
+                logger_event(3, EV_SERVER_STOP, 0, getpid(), 0, 0);
+                logger_destroy();
+                return 1;
+            }
 
             mqd_t mq_queries_from_clients = mq_open("/mq_queries_queue", O_CREAT | O_RDONLY, 0444, &attr);
+            if(mq_queries_from_clients == -1 && errno == EINVAL) {
+                logger_log(2, "(%s:%d) Queue depth %ld is not allowed, using %d.", __FILENAME__, __LINE__, config.queue_depth,
+                           DEFAULT_QUEUE_DEPTH);
+                attr.mq_maxmsg = DEFAULT_QUEUE_DEPTH;
+                mq_queries_from_clients = mq_open("/mq_queries_queue", O_CREAT | O_RDONLY, 0444, &attr);
+            }
+            if(mq_queries_from_clients == -1) {
+                logger_log(1, "(%s:%d) %s", __FILENAME__, __LINE__, "Cannot create query queue.");
+                pthread_cancel(reaper_thread);
+                pthread_join(reaper_thread, NULL);
+                pthread_cond_destroy(&children_cond);
+                pthread_mutex_destroy(&mutex);
+                logger_event(3, EV_SERVER_STOP, 0, getpid(), 0, 0);
+                logger_destroy();
+                return 1;
+            }
             printf("Server has started with PID:%d.\n", getpid());
             printf("Waiting for tasks...\n");
 
             struct linked_list_t *ll;
             ll = ll_create();
+            dump_list = ll;
 
-            pthread_mutex_init(&mutex, NULL);
             long sequence = 1;
-            struct query_t query;
+            struct query_t *query = malloc(sizeof(struct query_t));
 
             int is_stopped = 0;
+            if(query == NULL) {
+                logger_log(1, "(%s:%d) %s", __FILENAME__, __LINE__, "Cannot allocate query buffer.");
+                is_stopped = 1;
+            }
 
             while (!is_stopped) {
-                mq_receive(mq_queries_from_clients, (char *) &query, sizeof(struct query_t), NULL);
-                switch (query.command) {
-                    case ADD:
-                        printf("TASK: add %s %s\n", query.timer_spec, query.task);
-                        logger_log(2, "(%s:%d) TASK: add %s %s", __FILENAME__, __LINE__, query.timer_spec, query.task);
-                        struct task_t *new_task = (struct task_t*) malloc(sizeof(struct task_t));
-
-                        new_task->task_id = sequence++;
-                        get_argv_for_task(new_task, query);
+                if(mq_receive(mq_queries_from_clients, (char *) query, sizeof(struct query_t), NULL) == -1)
+                    continue;
+                switch (query->command) {
+                    case ADD:;
+                        struct task_t *new_task = create_task(query);
+                        if(new_task == NULL) {
+                            reject_task(query->client_pid, INVALID_QUERY);
+                            break;
+                        }
+
+                        if(task_count >= config.max_tasks || task_memory + new_task->memory > config.max_memory)
+                            ll_remove_done(ll);
+                        if(task_count >= config.max_tasks || task_memory + new_task->memory > config.max_memory) {
+                            new_task->query = NULL;
+                            free_task(new_task);
+                            reject_task(query->client_pid, task_count >= config.max_tasks ? OVER_TASK_LIMIT : OVER_MEMORY_LIMIT);
+                            break;
+                        }
+                        struct query_t *next_query = malloc(sizeof(struct query_t));
+                        if(next_query == NULL) {
+                            new_task->query = NULL;
+                            free_task(new_task);
+                            reject_task(query->client_pid, OVER_MEMORY_LIMIT);
+                            break;
+                        }
+                        query = next_query;
 
-                        strcpy(new_task->time_spec, query.timer_spec);
-                        new_task->is_cyclic = 0;
                         new_task->is_done = 0;
-                        long task_execution_time;
-                        long interval_time;
-                        int is_absolute = get_task_time(&query, &task_execution_time, &interval_time);
+                        long task_execution_time = new_task->query->execution_time;
+                        long interval_time = new_task->query->interval_time;
+                        int is_absolute = new_task->query->is_absolute;
                         new_task->is_cyclic = interval_time > 0 ? 1 : 0;
+                        new_task->interval_time = interval_time;
 
                         timer_t timer_id;
                         struct sigevent event;
@@ -124,31 +277,48 @@ int main(int argc, char **argv) {
                         event.sigev_notify_function = timer_notification_thread;
                         event.sigev_value.sival_ptr = new_task;
                         event.sigev_notify_attributes = NULL;
-                        timer_create(CLOCK_REALTIME, &event, &timer_id);
+                        if(timer_create(CLOCK_REALTIME, &event, &timer_id)) {
+                            pid_t client_pid = new_task->query->client_pid;
+                            free_task(new_task);
+                            reject_task(client_pid, TIMER_ERROR);
+                            break;
+                        }
                         new_task->timer_id = timer_id;
-                        ll_push_back(ll, &new_task);
+                        new_task->task_id = sequence++;
+                        if(ll_push_back(ll, &new_task)) {
+                            pid_t client_pid = new_task->query->client_pid;
+                            timer_delete(timer_id);
+                            free_task(new_task);
+                            reject_task(client_pid, TIMER_ERROR);
+                            break;
+                        }
 
                         struct itimerspec spec;
                         spec.it_value.tv_sec = task_execution_time;
                         spec.it_value.tv_nsec = 0;
                         spec.it_interval.tv_sec = interval_time;
                         spec.it_interval.tv_nsec = 0;
-                        timer_settime(timer_id, is_absolute ? TIMER_ABSTIME : 0, &spec, NULL);
+                        pid_t client_pid = new_task->query->client_pid;
+                        long task_id = new_task->task_id;
+                        if(timer_settime(timer_id, is_absolute ? TIMER_ABSTIME : 0, &spec, NULL)) {
+                            ll_remove(ll, task_id, 1);
+                            reject_task(client_pid, TIMER_ERROR);
+                            break;
+                        }
+                        logger_event(2, EV_TASK_ADD, task_id, 0, 0, 0);
+                        send_add_response(client_pid, OK, task_id);
                         break;
                     case CANCEL:;
-                        long id = strtol(query.task, NULL, 10);
-                        printf("TASK: cancel %ld\n", id);
-                        logger_log(1, "(%s:%d) TASK: cancel %ld", __FILENAME__, __LINE__, id);
-                        ll_remove(ll, id);
+                        long id = query->task_id;
+                        logger_event(1, EV_TASK_CANCEL, id, 0, 0, 0);
+                        ll_remove(ll, id, 0);
                         break;
                     case DISPLAY:
-                        printf("TASK: display\n");
-                        logger_log(3, "(%s:%d) TASK: display", __FILENAME__, __LINE__);
-                        send_task_list(ll);
+                        logger_event(3, EV_TASK_DISPLAY, 0, 0, 0, 0);
+                        send_task_list(ll, query->client_pid);
                         break;
                     case STOP:
-                        printf("TASK: stop\n");
-                        logger_log(1, "(%s:%d) TASK: stop", __FILENAME__, __LINE__);
+                        logger_event(1, EV_TASK_STOP, 0, 0, 0, 0);
                         is_stopped = 1;
                         break;
                 }
@@ -156,12 +326,17 @@ int main(int argc, char **argv) {
             }
 
             printf("Server has terminated.\n");
+            free(query);
             ll_clear(ll);
             free(ll);
             mq_close(mq_queries_from_clients);
             mq_unlink("/mq_queries_queue");
+            pthread_cancel(reaper_thread);
+            pthread_join(reaper_thread, NULL);
+            clear_children();
+            pthread_cond_destroy(&children_cond);
             pthread_mutex_destroy(&mutex);
-            logger_log(3, "(%s:%d) Server has terminated.", __FILENAME__, __LINE__);
+            logger_event(3, EV_SERVER_STOP, 0, getpid(), 0, 0);
             logger_destroy();
         }
         else {
@@ -188,154 +363,411 @@ void timer_notification_thread(union sigval arg) {
     if(!timer_task->is_cyclic)
         timer_task->is_done = 1;
 
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long lateness = now.tv_sec * 1000000000 + now.tv_nsec - timer_task->next_execution;
+    if(timer_task->is_cyclic) {
+        int overrun = timer_getoverrun(timer_task->timer_id);
+        long expirations = overrun > 0 ? overrun + 1 : 1;
+        long interval = timer_task->interval_time * 1000000000;
+        if(expirations > (LONG_MAX - timer_task->next_execution) / interval)
+            timer_task->next_execution = LONG_MAX;
+        else
+            timer_task->next_execution += expirations * interval;
+    }
+
+    stats.fired++;
+    long task_id = timer_task->task_id;
     pid_t child_pid;
-    posix_spawn(&child_pid, *timer_task->argv, NULL, NULL, timer_task->argv, NULL);
+    int error = posix_spawn(&child_pid, *timer_task->argv, NULL, NULL, timer_task->argv, NULL);
+    if(!error) {
+        struct child_t *child = malloc(sizeof(struct child_t));
+        if(child != NULL) {
+            child->pid = child_pid;
+            child->task_id = task_id;
+            child->next = children;
+            children = child;
+            pthread_cond_signal(&children_cond);
+        }
+    }
     pthread_mutex_unlock(&mutex);
+
+    if(error)
+        logger_event(1, EV_TASK_FIRE, task_id, 0, lateness, error);
+    else
+        logger_event(3, EV_TASK_FIRE, task_id, child_pid, lateness, 0);
 }
 
-void send_task_list(const struct linked_list_t *ll) {
-    mqd_t mq_response_to_client;
-    do {
-        mq_response_to_client = mq_open("/mq_response_queue", O_WRONLY);
-        sleep(1);
-    } while (mq_response_to_client == -1);
+void* reap_children(void* arg) {
+    while(1) {
+        pthread_mutex_lock(&mutex);
+        pthread_cleanup_push(unlock_mutex, NULL);
+        while(children == NULL)
+            pthread_cond_wait(&children_cond, &mutex);
+        pthread_cleanup_pop(1);
+
+        siginfo_t info;
+        if(waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) == -1) {
+            if(errno == ECHILD)
+                clear_children();
+            continue;
+        }
+
+        long task_id = -1;
+        pthread_mutex_lock(&mutex);
+        pid_t dump_pid = logger_dump_pid();
+        for(struct child_t **current = &children; *current != NULL; current = &(*current)->next) {
+            if((*current)->pid == info.si_pid) {
+                struct child_t *child = *current;
+                task_id = child->task_id;
+                *current = child->next;
+                free(child);
+                break;
+            }
+        }
+        pthread_mutex_unlock(&mutex);
+
+        if(task_id == -1 && info.si_pid == dump_pid) {
+            struct timespec delay = {0, 10000000};
+            nanosleep(&delay, NULL);
+            continue;
+        }
+        waitid(P_PID, info.si_pid, &info, WEXITED);
+        if(task_id == -1)
+            continue;
+        int exit_code = info.si_code == CLD_EXITED ? info.si_status : -info.si_status;
+        logger_event(exit_code ? 2 : 3, EV_TASK_EXIT, task_id, info.si_pid, 0, exit_code);
+    }
+}
+
+void unlock_mutex(void* arg) {
+    pthread_mutex_unlock(&mutex);
+}
+
+void clear_children() {
+    pthread_mutex_lock(&mutex);
+    while(children != NULL) {
+        struct child_t *child = children;
+        children = child->next;
+        free(child);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+void send_task_list(const struct linked_list_t *ll, pid_t client_pid) {
+    mqd_t mq_response_to_client = open_response_queue(client_pid, O_WRONLY);
+    if(mq_response_to_client == -1)
+        return;
 
-    struct response_t response;
     pthread_mutex_lock(&mutex);
-    for(struct node_t* current = ll->head; current != NULL; current = current->next) {
-        if(!current->timer_task->is_done) {
-            response.task_id = current->timer_task->task_id;
-            strcpy(response.time_spec, current->timer_task->time_spec);
-            strcpy(response.task, "");
-            for (int i = 0; *(current->timer_task->argv + i) != NULL; i++) {
-                strcat(response.task, *(current->timer_task->argv + i));
-                strcat(response.task, " ");
+    int count = 0;
+    struct response_t *responses = malloc(sizeof(struct response_t) * (task_count > 0 ? task_count : 1));
+    if(responses != NULL) {
+        for(struct node_t* current = ll->head; current != NULL; current = current->next) {
+            if(!current->timer_task->is_done) {
+                struct response_t *response = responses + count++;
+                response->status = OK;
+                response->task_id = current->timer_task->task_id;
+                strcpy(response->time_spec, current->timer_task->time_spec);
+                strcpy(response->task, "");
+                for (int i = 0; *(current->timer_task->argv + i) != NULL; i++) {
+                    strncat(response->task, *(current->timer_task->argv + i), sizeof(response->task) - strlen(response->task) - 1);
+                    strncat(response->task, " ", sizeof(response->task) - strlen(response->task) - 1);
+                }
             }
-            mq_send(mq_response_to_client, (char *) &response, sizeof(struct response_t), 0);
         }
     }
     pthread_mutex_unlock(&mutex);
+
+    struct timespec timeout;
+    for(int i = 0; i < count; i++) {
+        get_timeout(&timeout, SERVER_TIMEOUT);
+        if(mq_timedsend(mq_response_to_client, (char *) (responses + i), sizeof(struct response_t), 0, &timeout)) {
+            free(responses);
+            mq_close(mq_response_to_client);
+            return;
+        }
+    }
+    free(responses);
+
+    struct response_t response;
+    response.status = OK;
+    strcpy(response.task, "");
+    get_timeout(&timeout, SERVER_TIMEOUT);
+    mq_timedsend(mq_response_to_client, (char*) &response, sizeof(struct response_t), 0, &timeout);
+    mq_close(mq_response_to_client);
+}
+
+void send_add_response(pid_t client_pid, enum status_t status, long task_id) {
+    mqd_t mq_response_to_client = open_response_queue(client_pid, O_WRONLY);
+    if(mq_response_to_client == -1)
+        return;
+
+    struct response_t response;
+    response.status = status;
+    response.task_id = task_id;
+    strcpy(response.time_spec, "");
     strcpy(response.task, "");
-    mq_send(mq_response_to_client, (char*) &response, sizeof(struct response_t), 0);
+
+    struct timespec timeout;
+    get_timeout(&timeout, SERVER_TIMEOUT);
+    mq_timedsend(mq_response_to_client, (char*) &response, sizeof(struct response_t), 0, &timeout);
     mq_close(mq_response_to_client);
 }
 
-void get_argv_for_task(struct task_t *timer_task, struct query_t query) {
-    int argc = 1;
-    for(int i = 0; i < strlen(query.task); i++) {
-        if (*(query.task + i) == ' ')
-            argc++;
+mqd_t open_response_queue(pid_t client_pid, int flags) {
+    char name[50];
+    sprintf(name, "/mq_response_queue_%d", client_pid);
+
+    if(flags & O_CREAT) {
+        struct mq_attr attr;
+        attr.mq_maxmsg = 10;
+        attr.mq_msgsize = sizeof(struct response_t);
+        attr.mq_flags = 0;
+        mqd_t mq_response_queue = mq_open(name, flags | O_EXCL, 0622, &attr);
+        if(mq_response_queue == -1 && errno == EEXIST) {
+            mq_unlink(name);
+            mq_response_queue = mq_open(name, flags | O_EXCL, 0622, &attr);
+        }
+        return mq_response_queue;
     }
 
-    timer_task->argv = realloc(NULL, sizeof(char *) * argc);
-    char *temp;
-    temp = strtok(query.task, " ");
-    *timer_task->argv = calloc(sizeof(char), strlen(temp) + 1);
-    strcpy(*timer_task->argv, temp);
-    int counter = 1;
-    temp = strtok(NULL, " ");
-    while (temp) {
-        *(timer_task->argv + counter) = calloc(sizeof(char), strlen(temp) + 1);
-        strcpy(*(timer_task->argv + counter), temp);
-        temp = strtok(NULL, " ");
-        counter++;
+    return mq_open(name, flags);
+}
+
+void close_response_queue(mqd_t mq_response_queue, pid_t client_pid) {
+    char name[50];
+    sprintf(name, "/mq_response_queue_%d", client_pid);
+    mq_close(mq_response_queue);
+    mq_unlink(name);
+}
+
+void get_timeout(struct timespec *timeout, int seconds) {
+    clock_gettime(CLOCK_REALTIME, timeout);
+    timeout->tv_sec += seconds;
+}
+
+void get_config(struct config_t *config) {
+    config->queue_depth = get_config_value("CHRONO_QUEUE_DEPTH", DEFAULT_QUEUE_DEPTH);
+    long queue_depth_limit = get_queue_depth_limit();
+    if(queue_depth_limit > 0 && config->queue_depth > queue_depth_limit)
+        config->queue_depth = queue_depth_limit;
+    config->max_tasks = get_config_value("CHRONO_MAX_TASKS", DEFAULT_MAX_TASKS);
+    config->max_memory = get_config_value("CHRONO_MAX_MEMORY", DEFAULT_MAX_MEMORY);
+}
+
+long get_queue_depth_limit() {
+    FILE *file = fopen("/proc/sys/fs/mqueue/msg_max", "r");
+    if(file == NULL)
+        return -1;
+
+    long limit;
+    if(fscanf(file, "%ld", &limit) != 1)
+        limit = -1;
+    fclose(file);
+    return limit;
+}
 
+long get_config_value(const char *name, long default_value) {
+    char *value = getenv(name);
+    if(value == NULL)
+        return default_value;
+
+    long result = strtol(value, NULL, 10);
+    return result > 0 ? result : default_value;
+}
+
+struct task_t* create_task(struct query_t *query) {
+    if(query->argc < 1 || query->argc > QUERY_DATA_SIZE / (sizeof(uint16_t) + 1) || query->data_length > QUERY_DATA_SIZE)
+        return NULL;
+    if(query->interval_time < 0 || (query->is_absolute != 0 && query->is_absolute != 1))
+        return NULL;
+    if(query->is_absolute ? query->execution_time < 0 : query->execution_time <= 0)
+        return NULL;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long now_ns = now.tv_sec * 1000000000 + now.tv_nsec;
+    long max_execution_time = query->is_absolute ? MAX_SCHEDULE_SECONDS : (LONG_MAX - now_ns) / 1000000000;
+    if(query->execution_time > max_execution_time)
+        return NULL;
+    long execution_ns = query->execution_time * 1000000000 + (query->is_absolute ? 0 : now_ns);
+    if(query->interval_time > (LONG_MAX - execution_ns) / 1000000000)
+        return NULL;
+
+    struct task_t *timer_task = malloc(sizeof(struct task_t) + sizeof(char *) * (query->argc + 1));
+    if(timer_task == NULL)
+        return NULL;
+    timer_task->argv = (char **) (timer_task + 1);
+
+    size_t offset = 0;
+    if(read_query_string(query, &offset, &timer_task->time_spec) || strlen(timer_task->time_spec) >= TIME_SPEC_SIZE) {
+        free(timer_task);
+        return NULL;
     }
-    *(timer_task->argv + counter) = NULL;
+    for(int i = 0; i < query->argc; i++) {
+        if(read_query_string(query, &offset, timer_task->argv + i)) {
+            free(timer_task);
+            return NULL;
+        }
+    }
+    *(timer_task->argv + query->argc) = NULL;
+
+    timer_task->query = query;
+    timer_task->next_execution = execution_ns;
+    timer_task->memory = sizeof(struct task_t) + sizeof(char *) * (query->argc + 1) + sizeof(struct query_t)
+            + sizeof(struct node_t);
+    return timer_task;
+}
+
+void reject_task(pid_t client_pid, enum status_t status) {
+    logger_event(1, EV_TASK_REJECT, 0, client_pid, 0, status);
+    pthread_mutex_lock(&mutex);
+    stats.rejected++;
+    pthread_mutex_unlock(&mutex);
+    send_add_response(client_pid, status, 0);
+}
+
+int read_query_string(struct query_t *query, size_t *offset, char **string) {
+    uint16_t length;
+    if(*offset + sizeof(uint16_t) > query->data_length)
+        return 1;
+    memcpy(&length, query->data + *offset, sizeof(uint16_t));
+    *offset += sizeof(uint16_t);
+
+    if(*offset + length + 1 > query->data_length || *(query->data + *offset + length) != '\0')
+        return 1;
+    *string = query->data + *offset;
+    *offset += length + 1;
+    return 0;
 }
 
-int get_task_time(struct query_t *query, long *task_execution_time, long *interval_time) {
-    char* timer_spec = query->timer_spec;
+int get_task_time(char *timer_spec, long *task_execution_time, long *interval_time) {
     *task_execution_time = 0;
     *interval_time = 0;
     int is_absolute = 0;
     char* temp = strtok(timer_spec, " ");
+    if(temp == NULL)
+        return -1;
+
     if(strcmp(temp, "-r") == 0) {
-        temp = strtok(NULL, "-");
-        *task_execution_time += strtol(temp, NULL, 10) * 365 * 24 * 60 * 60;
-        temp = strtok(NULL, "-");
-        *task_execution_time += strtol(temp, NULL, 10) * 24 * 60 * 60;
-        temp = strtok(NULL, "-");
-        *task_execution_time += strtol(temp, NULL, 10) * 60 * 60;
-        temp = strtok(NULL, "-");
-        *task_execution_time += strtol(temp, NULL, 10) * 60;
-        temp = strtok(NULL, " ");
-        *task_execution_time += strtol(temp, NULL, 10);
+        if(get_duration(task_execution_time))
+            return -1;
+    }
+    else if(strcmp(temp, "-a") == 0) {
+        is_absolute = 1;
+        time_t now = time(NULL);
+        struct tm *lt = localtime(&now);
+        struct tm at;
+        long day, month, year, hour, minute, second;
+        if(get_time_field(".", 1, 31, &day) || get_time_field(".", 1, 12, &month)
+                || get_time_field("-", 1970, 9999, &year) || get_time_field(":", 0, 23, &hour)
+                || get_time_field(":", 0, 59, &minute) || get_time_field(" ", 0, 60, &second))
+            return -1;
+        at.tm_mday = (int) day;
+        at.tm_mon = (int) month - 1;
+        at.tm_year = (int) year - 1900;
+        at.tm_hour = (int) hour;
+        at.tm_min = (int) minute;
+        at.tm_sec = (int) second;
+        at.tm_isdst = -1;
+        at.tm_zone = lt->tm_zone;
+        if((*task_execution_time = mktime(&at)) == -1 || at.tm_mday != day || at.tm_mon != month - 1)
+            return -1;
     }
     else {
-        if(strcmp(temp, "-a") == 0) {
-            is_absolute = 1;
-            time_t now = time(NULL);
-            struct tm *lt = localtime(&now);
-            struct tm at;
-            temp = strtok(NULL, ".");
-            at.tm_mday = (int) strtol(temp, NULL, 10);
-            temp = strtok(NULL, ".");
-            at.tm_mon = (int) strtol(temp, NULL, 10) - 1;
-            temp = strtok(NULL, "-");
-            at.tm_year = (int) strtol(temp, NULL, 10) - 1900;
-            temp = strtok(NULL, ":");
-            at.tm_hour = (int) strtol(temp, NULL, 10);
-            temp = strtok(NULL, ":");
-            at.tm_min = (int) strtol(temp, NULL, 10);
-            temp = strtok(NULL, " ");
-            at.tm_sec = (int) strtol(temp, NULL, 10);
-            at.tm_zone = lt->tm_zone;
-            *task_execution_time = mktime(&at);
-        }
+        return -1;
     }
 
     temp = strtok(NULL, " ");
     if(temp != NULL) {
-        if (strcmp(temp, "-i") == 0) {
-            temp = strtok(NULL, "-");
-            *interval_time += strtol(temp, NULL, 10) * 365 * 24 * 60 * 60;
-            temp = strtok(NULL, "-");
-            *interval_time += strtol(temp, NULL, 10) * 24 * 60 * 60;
-            temp = strtok(NULL, "-");
-            *interval_time += strtol(temp, NULL, 10) * 60 * 60;
-            temp = strtok(NULL, "-");
-            *interval_time += strtol(temp, NULL, 10) * 60;
-            temp = strtok(NULL, " ");
-            *interval_time += strtol(temp, NULL, 10);
-        }
+        if(strcmp(temp, "-i") != 0 || get_duration(interval_time))
+            return -1;
     }
 
     return is_absolute;
 }
 
+int get_duration(long *duration) {
+    const long units[] = {365 * 24 * 60 * 60, 24 * 60 * 60, 60 * 60, 60, 1};
+    const int units_count = sizeof(units) / sizeof(units[0]);
+
+    *duration = 0;
+    for(int i = 0; i < units_count; i++) {
+        long value;
+        if(get_time_field(i < units_count - 1 ? "-" : " ", 0, (MAX_SCHEDULE_SECONDS - *duration) / units[i], &value))
+            return 1;
+        *duration += value * units[i];
+    }
+
+    return 0;
+}
+
+int get_time_field(const char *delimiters, long min, long max, long *value) {
+    char *temp = strtok(NULL, delimiters);
+    if(temp == NULL)
+        return 1;
+
+    char *end;
+    errno = 0;
+    *value = strtol(temp, &end, 10);
+    if(end == temp || *end != '\0' || errno || *value < min || *value > max)
+        return 1;
+
+    return 0;
+}
+
 void run_client(const mqd_t *mq_queries_to_server, int argc, char **argv) {
     printf("CLIENT\n");
 
     if(argc > 1) {
 
         struct query_t query;
+        query.client_pid = getpid();
 
         if(strcmp(argv[1], commands[0]) == 0) {
-            fill_add_query(argc, argv, &query);
-            mq_send(*mq_queries_to_server, (char *) &query, sizeof(struct query_t), 0);
-
-            printf("SENT: %s %s %s\n", commands[query.command], query.timer_spec, query.task);
+            mqd_t mq_response_from_server;
+            if(fill_add_query(argc, argv, &query)) {
+                printf("Incorrect task!\n");
+            }
+            else if((mq_response_from_server = open_response_queue(query.client_pid, O_CREAT | O_RDONLY)) == -1) {
+                printf("Cannot create response queue.\n");
+            }
+            else {
+                if(send_query(mq_queries_to_server, &query) == 0) {
+                    printf("SENT: %s %s", commands[query.command], query.data + sizeof(uint16_t));
+                    for(int i = argc - query.argc; i < argc; i++)
+                        printf(" %s", argv[i]);
+                    printf("\n");
+                    receive_add_response(mq_response_from_server);
+                }
+                close_response_queue(mq_response_from_server, query.client_pid);
+            }
         }
-        else if(strcmp(argv[1], commands[1]) == 0) {
+        else if(strcmp(argv[1], commands[1]) == 0 && argc > 2) {
             query.command = CANCEL;
-            strcpy(query.task, argv[2]);
-            mq_send(*mq_queries_to_server, (char *) &query, sizeof(struct query_t), 0);
-
-            printf("SENT: %s %s\n", commands[query.command], argv[2]);
+            query.task_id = strtol(argv[2], NULL, 10);
+            if(send_query(mq_queries_to_server, &query) == 0)
+                printf("SENT: %s %s\n", commands[query.command], argv[2]);
         }
         else if(strcmp(argv[1], commands[2]) == 0) {
             query.command = DISPLAY;
-            mq_send(*mq_queries_to_server, (char *) &query, sizeof(struct query_t), 0);
-            printf("SENT: %s\n", commands[query.command]);
-
-            display_task_list();
+            mqd_t mq_response_from_server = open_response_queue(query.client_pid, O_CREAT | O_RDONLY);
+            if(mq_response_from_server == -1) {
+                printf("Cannot create response queue.\n");
+            }
+            else {
+                if(send_query(mq_queries_to_server, &query) == 0) {
+                    printf("SENT: %s\n", commands[query.command]);
+                    display_task_list(mq_response_from_server);
+                }
+                close_response_queue(mq_response_from_server, query.client_pid);
+            }
         }
         else if(strcmp(argv[1], commands[3]) == 0) {
             query.command = STOP;
-            mq_send(*mq_queries_to_server, (char *) &query, sizeof(struct query_t), 0);
-
-            printf("SENT: %s\n", commands[query.command]);
+            if(send_query(mq_queries_to_server, &query) == 0)
+                printf("SENT: %s\n", commands[query.command]);
         }
         else {
             printf("Incorrect command!\n");
@@ -345,36 +777,90 @@ void run_client(const mqd_t *mq_queries_to_server, int argc, char **argv) {
     }
 }
 
-void fill_add_query(int argc, char** argv, struct query_t *query) {
+int send_query(const mqd_t *mq_queries_to_server, struct query_t *query) {
+    struct timespec timeout;
+    get_timeout(&timeout, CLIENT_TIMEOUT);
+    if(mq_timedsend(*mq_queries_to_server, (char *) query, sizeof(struct query_t), command_priorities[query->command], &timeout)) {
+        if(errno == ETIMEDOUT)
+            printf("Server is busy, try again later.\n");
+        else
+            printf("Cannot send query to server.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int fill_add_query(int argc, char** argv, struct query_t *query) {
+    if(argc < 5)
+        return 1;
+
     query->command = ADD;
+    char timer_spec[TIME_SPEC_SIZE];
     int index = 4;
     if(strcmp(argv[4], "-i") == 0) {
-        sprintf(query->timer_spec, "%s %s %s %s", argv[2], argv[3], argv[4], argv[5]);
+        if(argc < 7)
+            return 1;
+        snprintf(timer_spec, TIME_SPEC_SIZE, "%s %s %s %s", argv[2], argv[3], argv[4], argv[5]);
         index = 6;
     }
     else {
-        sprintf(query->timer_spec, "%s %s", argv[2], argv[3]);
+        snprintf(timer_spec, TIME_SPEC_SIZE, "%s %s", argv[2], argv[3]);
     }
 
-    sprintf(query->task, "%s ", argv[index]);
-    for(int i = index + 1; i < argc; i++) {
-        strcat(query->task, argv[i]);
-        strcat(query->task, " ");
+    query->data_length = 0;
+    query->argc = argc - index;
+    if(write_query_string(query, timer_spec))
+        return 1;
+    for(int i = index; i < argc; i++) {
+        if(write_query_string(query, argv[i]))
+            return 1;
     }
+
+    query->is_absolute = get_task_time(timer_spec, &query->execution_time, &query->interval_time);
+    if(query->is_absolute == -1)
+        return 1;
+    return 0;
 }
 
-void display_task_list() {
-    struct mq_attr attr;
+int write_query_string(struct query_t *query, const char *string) {
+    size_t length = strlen(string);
+    if(length > UINT16_MAX || query->data_length + sizeof(uint16_t) + length + 1 > QUERY_DATA_SIZE)
+        return 1;
+
+    uint16_t prefix = length;
+    memcpy(query->data + query->data_length, &prefix, sizeof(uint16_t));
+    query->data_length += sizeof(uint16_t);
+    memcpy(query->data + query->data_length, string, length + 1);
+    query->data_length += length + 1;
+    return 0;
+}
+
+void receive_add_response(mqd_t mq_response_from_server) {
+    struct response_t response;
+    struct timespec timeout;
+    get_timeout(&timeout, CLIENT_TIMEOUT);
+    if(mq_timedreceive(mq_response_from_server, (char*) &response, sizeof(struct response_t), NULL, &timeout) == -1) {
+        printf("Server is busy, the task may not have been added.\n");
+        return;
+    }
 
-    attr.mq_maxmsg = 10;
-    attr.mq_msgsize = sizeof(struct response_t);
-    attr.mq_flags = 0;
+    if(response.status == OK)
+        printf("ADDED: ID: %ld\n", response.task_id);
+    else
+        printf("REJECTED: %s\n", statuses[response.status]);
+}
 
+void display_task_list(mqd_t mq_response_from_server) {
     int counter = 0;
     struct response_t response;
-    mqd_t mq_response_from_server = mq_open("/mq_response_queue", O_CREAT | O_RDONLY, 0444, &attr);
+    struct timespec timeout;
     while(1) {
-        mq_receive(mq_response_from_server, (char*) &response, sizeof(struct response_t), 0);
+        get_timeout(&timeout, CLIENT_TIMEOUT);
+        if(mq_timedreceive(mq_response_from_server, (char*) &response, sizeof(struct response_t), NULL, &timeout) == -1) {
+            printf("Server is busy, task list is incomplete.\n");
+            break;
+        }
         if(strcmp(response.task, "") == 0)
             break;
         printf("ID: %ld %s %s\n", (long)response.task_id, response.time_spec, response.task);
@@ -382,13 +868,78 @@ void display_task_list() {
     }
     if(counter < 1)
         printf("Task list is empty.\n");
+}
 
-    mq_close(mq_response_from_server);
-    mq_unlink("/mq_response_queue");
+void lock_dump_data() {
+    pthread_mutex_lock(&mutex);
+}
+
+void unlock_dump_data() {
+    pthread_mutex_unlock(&mutex);
 }
 
-void* get_dump_data() {
-    return data;
+int write_dump_data(int fd) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    struct dump_header_t header;
+    memcpy(header.magic, DUMP_MAGIC, sizeof(header.magic));
+    header.version = DUMP_VERSION;
+    header.timestamp = (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+    header.task_count = task_count;
+    header.tasks_added = stats.added;
+    header.tasks_rejected = stats.rejected;
+    header.tasks_cancelled = stats.cancelled;
+    header.tasks_fired = stats.fired;
+    if(write_dump_bytes(fd, &header, sizeof(struct dump_header_t)))
+        return 1;
+
+    if(dump_list == NULL)
+        return 0;
+
+    char record[sizeof(struct dump_task_t) + QUERY_DATA_SIZE];
+    for(struct node_t* current = dump_list->head; current != NULL; current = current->next) {
+        struct task_t *timer_task = current->timer_task;
+        struct dump_task_t task;
+        task.task_id = timer_task->task_id;
+        task.next_execution = timer_task->next_execution;
+        task.interval_time = timer_task->interval_time;
+        task.is_cyclic = timer_task->is_cyclic;
+        task.is_done = timer_task->is_done;
+        task.time_spec_length = strlen(timer_task->time_spec);
+
+        size_t length = sizeof(struct dump_task_t);
+        memcpy(record + length, timer_task->time_spec, task.time_spec_length);
+        length += task.time_spec_length;
+        for(int i = 0; *(timer_task->argv + i) != NULL; i++) {
+            size_t argument_length = strlen(*(timer_task->argv + i)) + 1;
+            memcpy(record + length, *(timer_task->argv + i), argument_length);
+            length += argument_length;
+        }
+        task.argv_length = length - sizeof(struct dump_task_t) - task.time_spec_length;
+        memcpy(record, &task, sizeof(struct dump_task_t));
+
+        if(write_dump_bytes(fd, record, length))
+            return 1;
+    }
+
+    return 0;
+}
+
+int write_dump_bytes(int fd, const void *buffer, size_t size) {
+    const char *current = buffer;
+    while(size > 0) {
+        ssize_t written = write(fd, current, size);
+        if(written == -1) {
+            if(errno == EINTR)
+                continue;
+            return 1;
+        }
+        current += written;
+        size -= written;
+    }
+
+    return 0;
 }
 
 struct linked_list_t* ll_create() {
@@ -416,6 +967,9 @@ int ll_push_back(struct linked_list_t* ll, struct task_t **new_task) {
         ll->tail->next = node;
         ll->tail = node;
     }
+    task_count++;
+    task_memory += node->timer_task->memory;
+    stats.added++;
 
     pthread_mutex_unlock(&mutex);
     return 0;
@@ -432,15 +986,19 @@ int ll_size(const struct linked_list_t* ll) {
     return counter;
 }
 
+void free_task(struct task_t *timer_task) {
+    free(timer_task->query);
+    free(timer_task);
+}
+
 void free_node(struct node_t * node) {
-    for(int i = 0; *(node->timer_task->argv + i) != NULL; i++)
-        free(*(node->timer_task->argv + i));
-    free(node->timer_task->argv);
-    free(node->timer_task);
+    task_count--;
+    task_memory -= node->timer_task->memory;
+    free_task(node->timer_task);
     free(node);
 }
 
-void ll_remove(struct linked_list_t* ll, long index) {
+void ll_remove(struct linked_list_t* ll, long index, int is_rollback) {
     pthread_mutex_lock(&mutex);
 
     int size = ll_size(ll);
@@ -449,11 +1007,13 @@ void ll_remove(struct linked_list_t* ll, long index) {
         return;
     }
 
+    int is_removed = 0;
     if(ll->head == ll->tail) {
         if(ll->head->timer_task->task_id == index) {
             timer_delete(ll->head->timer_task->timer_id);
             free_node(ll->head);
             ll->head = ll->tail = NULL;
+            is_removed = 1;
         }
     }
     else {
@@ -462,6 +1022,7 @@ void ll_remove(struct linked_list_t* ll, long index) {
             timer_delete(ll->head->timer_task->timer_id);
             free_node(ll->head);
             ll->head = temp;
+            is_removed = 1;
         }
         else {
             struct node_t *current;
@@ -471,6 +1032,7 @@ void ll_remove(struct linked_list_t* ll, long index) {
                     timer_delete(current->next->timer_task->timer_id);
                     free_node(current->next);
                     current->next = temp;
+                    is_removed = 1;
                     if (temp == NULL) {
                         ll->tail = current;
                         break;
@@ -480,6 +1042,10 @@ void ll_remove(struct linked_list_t* ll, long index) {
         }
     }
 
+    if(is_removed && is_rollback)
+        stats.added--;
+    else if(is_removed)
+        stats.cancelled++;
     pthread_mutex_unlock(&mutex);
 }
 
@@ -499,4 +1065,32 @@ void ll_clear(struct linked_list_t* ll) {
 
     ll->head = ll->tail = NULL;
     pthread_mutex_unlock(&mutex);
+}
+
+void ll_remove_done(struct linked_list_t* ll) {
+    pthread_mutex_lock(&mutex);
+    if(ll == NULL || ll->head == NULL || ll->tail == NULL) {
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+
+    struct node_t* previous = NULL;
+    for(struct node_t* current = ll->head; current != NULL;) {
+        struct node_t* temp = current->next;
+        if(current->timer_task->is_done) {
+            timer_delete(current->timer_task->timer_id);
+            free_node(current);
+            if(previous == NULL)
+                ll->head = temp;
+            else
+                previous->next = temp;
+        }
+        else {
+            previous = current;
+        }
+        current = temp;
+    }
+
+    ll->tail = previous;
+    pthread_mutex_unlock(&mutex);
 }
\ No newline at end of file